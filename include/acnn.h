@@ -25,6 +25,7 @@
 #define ERR_INVALID_ARGUMENTS -5
 #define ERR_FILE_WRITE_FAILED -6
 #define ERR_FILE_OPEN_FAILED -7
+#define ERR_OUT_OF_MEMORY -8
 
 struct superblock {
     uint32_t magic_number;
@@ -55,6 +56,7 @@ struct dir_entry {
 void log_error(const char *format, ...);
 void log_info(const char *format, ...);
 uint32_t allocate_data_block(uint8_t *image, uint32_t total_blocks, struct superblock *sb);
+uint32_t allocate_data_run(uint8_t *image, struct superblock *sb, uint32_t count);
 void free_data_block(uint8_t *image, struct superblock *sb, uint32_t block_index);
 int create_directory(uint8_t *image, struct superblock *sb, uint32_t parent_inode_idx, const char *name);
 void list_directory(uint8_t *image, struct superblock *sb, uint32_t dir_inode_idx);
@@ -63,10 +65,25 @@ int find_dir_entry(uint8_t *image, struct superblock *sb, uint32_t dir_inode_idx
 int add_dir_entry(uint8_t *image, struct superblock *sb, uint32_t dir_inode_idx, uint32_t file_inode_idx, const char *name);
 void read_file(uint8_t *image, struct inode *file_inode, char *buffer, size_t buffer_size);
 void write_file(uint8_t *image, struct superblock *sb, struct inode *file_inode, const char *data);
+int write_file_at(uint8_t *image, struct superblock *sb, struct inode *file_inode, uint32_t offset, const char *data, size_t len);
+int acnn_fallocate(uint8_t *image, struct superblock *sb, struct inode *file_inode, uint32_t offset, uint32_t len);
 void initialize_reserved_blocks(uint8_t *image, struct superblock *sb);
 uint32_t allocate_inode(uint8_t *image, struct superblock *sb);
 
+/*
+ * Dirty block tracking keeps its state in acnn-sync.c, so only one image per
+ * process is supported. Call acnn_dirty_init() before mutating the image;
+ * until then the mark_* functions do nothing and acnn_sync() fails.
+ */
+int acnn_dirty_init(uint32_t total_blocks);
+void acnn_dirty_free(void);
+void mark_block_dirty(uint32_t block_index);
+void mark_block_discard(uint32_t block_index);
+void mark_block_prealloc(uint32_t block_index);
+void mark_range_dirty(uint8_t *image, const void *addr, size_t len);
+int acnn_sync(uint8_t *image, int fd, int datasync);
+
 size_t parse_size(char *arg);
-void cleanup(uint8_t *image, FILE *out);
+void cleanup(uint8_t *image, int fd);
 
 #endif
\ No newline at end of file
@@ -1,6 +1,13 @@
 #include "../include/acnn.h"
 #include <string.h>
 
+/*
+ * Allocation does not zero blocks. The image starts out calloc'd,
+ * initialize_reserved_blocks() claims the metadata blocks including the
+ * whole inode table, free_data_block() clears a block on release, and
+ * anything else written directly into the image must claim its block in
+ * the bitmap first, so a block is already zero when it is handed out.
+ */
 uint32_t allocate_data_block(uint8_t *image, uint32_t total_blocks, struct superblock *sb) {
     if (!image || !sb) {
         log_error("Invalid arguments passed to allocate_data_block");
@@ -16,8 +23,7 @@ uint32_t allocate_data_block(uint8_t *image, uint32_t total_blocks, struct super
         if (!(block_bitmap[byte_idx] & (1 << bit_idx))) {
             block_bitmap[byte_idx] |= (1 << bit_idx);
             sb->free_blocks--;
-
-            memset(image + i * BLOCK_SIZE, 0, BLOCK_SIZE);
+            mark_block_dirty(BLOCK_BITMAP_BLOCK);
 
             return i;
         }
@@ -27,6 +33,39 @@ uint32_t allocate_data_block(uint8_t *image, uint32_t total_blocks, struct super
     return (uint32_t)-1;
 }
 
+uint32_t allocate_data_run(uint8_t *image, struct superblock *sb, uint32_t count) {
+    if (!image || !sb || count == 0) {
+        log_error("Invalid arguments passed to allocate_data_run");
+        return (uint32_t)-1;
+    }
+
+    uint8_t *block_bitmap = image + BLOCK_SIZE * BLOCK_BITMAP_BLOCK;
+    uint32_t run_start = 0;
+    uint32_t run_len = 0;
+
+    for (uint32_t i = 0; i < sb->total_blocks; i++) {
+        if (block_bitmap[i / 8] & (1 << (i % 8))) {
+            run_len = 0;
+            continue;
+        }
+
+        if (run_len == 0) run_start = i;
+        if (++run_len < count) continue;
+
+        for (uint32_t b = run_start; b < run_start + count; b++) {
+            block_bitmap[b / 8] |= (1 << (b % 8));
+            mark_block_prealloc(b);
+        }
+        sb->free_blocks -= count;
+        mark_block_dirty(BLOCK_BITMAP_BLOCK);
+
+        return run_start;
+    }
+
+    log_error("No run of %u contiguous free blocks in block bitmap", count);
+    return (uint32_t)-1;
+}
+
 void free_data_block(uint8_t *image, struct superblock *sb, uint32_t block_index) {
     if (!image || !sb) {
         log_error("Invalid arguments passed to free_data_block");
@@ -44,16 +83,30 @@ void free_data_block(uint8_t *image, struct superblock *sb, uint32_t block_index
 
     block_bitmap[byte_idx] &= ~(1 << bit_idx);
     sb->free_blocks++;
+    mark_block_dirty(BLOCK_BITMAP_BLOCK);
+
+    memset(image + block_index * BLOCK_SIZE, 0, BLOCK_SIZE);
+    mark_block_discard(block_index);
 
     memcpy(image + BLOCK_SIZE * SUPERBLOCK_BLOCK, sb, sizeof(struct superblock));
+    mark_block_dirty(SUPERBLOCK_BLOCK);
 }
 
 void initialize_reserved_blocks(uint8_t *image, struct superblock *sb) {
     uint8_t *block_bitmap = image + BLOCK_SIZE * BLOCK_BITMAP_BLOCK;
-    for (uint32_t i = 0; i <= INODE_TABLE_BLOCK; i++) {
+
+    // The inode table starts at INODE_TABLE_BLOCK and spans as many blocks as the inodes need
+    size_t inode_table_bytes = (size_t)sb->total_inodes * sizeof(struct inode);
+    uint32_t inode_table_blocks = (inode_table_bytes + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    uint32_t last_reserved = INODE_TABLE_BLOCK + (inode_table_blocks ? inode_table_blocks - 1 : 0);
+
+    for (uint32_t i = 0; i <= last_reserved && i < sb->total_blocks; i++) {
         uint32_t byte_idx = i / 8;
         uint32_t bit_idx = i % 8;
+        if (block_bitmap[byte_idx] & (1 << bit_idx)) continue;
+
         block_bitmap[byte_idx] |= (1 << bit_idx);
         sb->free_blocks--;
     }
+    mark_block_dirty(BLOCK_BITMAP_BLOCK);
 }
\ No newline at end of file
@@ -27,9 +27,11 @@ int create_directory(uint8_t *image, struct superblock *sb, uint32_t parent_inod
     memset(dir_inode, 0, sizeof(struct inode));
     dir_inode->direct_blocks[0] = dir_data_block;
     dir_inode->size = 0;
+    mark_range_dirty(image, dir_inode, sizeof(struct inode));
 
     struct dir_entry *entries = (struct dir_entry *)(image + BLOCK_SIZE * dir_data_block);
     memset(entries, 0, BLOCK_SIZE);
+    mark_block_dirty(dir_data_block);
 
     log_info("Initialized directory block %u for '%s'", dir_data_block, name);
 
@@ -65,10 +67,12 @@ int delete_directory(uint8_t *image, struct superblock *sb, uint32_t dir_inode_i
     }
 
     memset(dir_inode, 0, sizeof(struct inode));
+    mark_range_dirty(image, dir_inode, sizeof(struct inode));
 
     uint8_t *inode_bitmap = image + BLOCK_SIZE * INODE_BITMAP_BLOCK;
     inode_bitmap[dir_inode_idx / 8] &= ~(1 << (dir_inode_idx % 8));
     sb->free_inodes++;
+    mark_block_dirty(INODE_BITMAP_BLOCK);
 
     struct inode *parent_inode = (struct inode *)(image + BLOCK_SIZE * INODE_TABLE_BLOCK) + sb->root_inode;
 
@@ -85,6 +89,8 @@ int delete_directory(uint8_t *image, struct superblock *sb, uint32_t dir_inode_i
                 entries[j].inode = 0; // Clear the directory entry
                 memset(entries[j].name, 0, MAX_FILENAME_LEN); // Clear the name
                 parent_inode->size -= sizeof(struct dir_entry);
+                mark_block_dirty(block);
+                mark_range_dirty(image, parent_inode, sizeof(struct inode));
                 return 0; // Success
             }
         }
@@ -155,6 +161,8 @@ int add_dir_entry(uint8_t *image, struct superblock *sb, uint32_t dir_inode_idx,
                 log_info("Adding directory entry: %s (inode %u) at block %u, entry %d", name, file_inode_idx, block, j);
                 entries[j] = entry;
                 dir_inode->size += sizeof(struct dir_entry);
+                mark_block_dirty(block);
+                mark_range_dirty(image, dir_inode, sizeof(struct inode));
                 return 0;
             }
         }
@@ -27,6 +27,7 @@ int create_file(uint8_t *image, struct superblock *sb, uint32_t inode_idx, const
 
         uint32_t chunk_size = (remaining_data > BLOCK_SIZE) ? BLOCK_SIZE : remaining_data;
         memcpy(image + BLOCK_SIZE * data_block, data + data_offset, chunk_size);
+        mark_block_dirty(data_block);
 
         if (data_block_index < 10) {
             file_inode->direct_blocks[data_block_index] = data_block;
@@ -41,12 +42,15 @@ int create_file(uint8_t *image, struct superblock *sb, uint32_t inode_idx, const
     }
 
     file_inode->size = strlen(data);
+    mark_range_dirty(image, file_inode, sizeof(struct inode));
 
     uint8_t *inode_bitmap = image + BLOCK_SIZE * INODE_BITMAP_BLOCK;
     inode_bitmap[inode_idx / 8] |= (1 << (inode_idx % 8));
     sb->free_inodes--;
+    mark_block_dirty(INODE_BITMAP_BLOCK);
 
     memcpy(image + BLOCK_SIZE * SUPERBLOCK_BLOCK, sb, sizeof(struct superblock));
+    mark_block_dirty(SUPERBLOCK_BLOCK);
 
     log_info("File created successfully with inode index %u", inode_idx);
     return 0; 
@@ -74,10 +78,12 @@ int delete_file(uint8_t *image, struct superblock *sb, uint32_t dir_inode_idx, c
     }
 
     memset(file_inode, 0, sizeof(struct inode));
+    mark_range_dirty(image, file_inode, sizeof(struct inode));
 
     uint8_t *inode_bitmap = image + BLOCK_SIZE * INODE_BITMAP_BLOCK;
     inode_bitmap[file_inode_idx / 8] &= ~(1 << (file_inode_idx % 8));
     sb->free_inodes++;
+    mark_block_dirty(INODE_BITMAP_BLOCK);
 
     struct inode *dir_inode = ((struct inode *)(image + BLOCK_SIZE * INODE_TABLE_BLOCK)) + dir_inode_idx;
     for (int i = 0; i < 10; i++) {
@@ -92,6 +98,8 @@ int delete_file(uint8_t *image, struct superblock *sb, uint32_t dir_inode_idx, c
                 entries[j].inode = 0; 
                 memset(entries[j].name, 0, MAX_FILENAME_LEN); 
                 dir_inode->size -= sizeof(struct dir_entry);
+                mark_block_dirty(block);
+                mark_range_dirty(image, dir_inode, sizeof(struct inode));
                 log_info("Directory entry for file '%s' removed", filename);
                 break;
             }
@@ -99,6 +107,7 @@ int delete_file(uint8_t *image, struct superblock *sb, uint32_t dir_inode_idx, c
     }
 
     memcpy(image + BLOCK_SIZE * SUPERBLOCK_BLOCK, sb, sizeof(struct superblock));
+    mark_block_dirty(SUPERBLOCK_BLOCK);
 
     log_info("File '%s' deleted successfully", filename);
     return 0; 
@@ -115,16 +124,23 @@ void read_file(uint8_t *image, struct inode *file_inode, char *buffer, size_t bu
         return;
     }
 
+    size_t limit = file_inode->size;
+    if (limit > buffer_size - 1)
+        limit = buffer_size - 1;
+
     size_t total_read = 0;
-    for (int i = 0; i < 10 && total_read < file_inode->size; i++) {
+    for (int i = 0; i < 10 && total_read < limit; i++) {
         uint32_t block = file_inode->direct_blocks[i];
-        if (block == 0) break;
 
         size_t to_read = BLOCK_SIZE;
-        if (file_inode->size - total_read < BLOCK_SIZE)
-            to_read = file_inode->size - total_read;
+        if (limit - total_read < BLOCK_SIZE)
+            to_read = limit - total_read;
 
-        memcpy(buffer + total_read, image + block * BLOCK_SIZE, to_read);
+        if (block == 0) {
+            memset(buffer + total_read, 0, to_read); // Hole
+        } else {
+            memcpy(buffer + total_read, image + block * BLOCK_SIZE, to_read);
+        }
         total_read += to_read;
     }
     buffer[total_read] = '\0';
@@ -154,6 +170,7 @@ void write_file(uint8_t *image, struct superblock *sb, struct inode *file_inode,
 
         size_t chunk = (remaining > BLOCK_SIZE) ? BLOCK_SIZE : remaining;
         memcpy(image + block * BLOCK_SIZE, data + data_offset, chunk);
+        mark_block_dirty(block);
         file_inode->direct_blocks[data_block_index++] = block;
 
         data_offset += chunk;
@@ -161,4 +178,98 @@ void write_file(uint8_t *image, struct superblock *sb, struct inode *file_inode,
         sb->free_blocks--;
     }
     file_inode->size = strlen(data);
+    mark_range_dirty(image, file_inode, sizeof(struct inode));
+}
+
+int write_file_at(uint8_t *image, struct superblock *sb, struct inode *file_inode, uint32_t offset, const char *data, size_t len) {
+    if (!image || !sb || !file_inode || !data) {
+        log_error("Invalid arguments passed to write_file_at");
+        return ERR_INVALID_ARGUMENTS;
+    }
+
+    if ((size_t)offset + len > 10 * BLOCK_SIZE) {
+        log_error("Write of %zu bytes at offset %u exceeds direct block limit", len, offset);
+        return ERR_FILE_TOO_LARGE;
+    }
+
+    size_t written = 0;
+    while (written < len) {
+        uint32_t pos = offset + written;
+        uint32_t index = pos / BLOCK_SIZE;
+        uint32_t block_offset = pos % BLOCK_SIZE;
+
+        uint32_t block = file_inode->direct_blocks[index];
+        if (block == 0) {
+            block = allocate_data_block(image, sb->total_blocks, sb);
+            if (block == (uint32_t)-1) {
+                log_error("No more space available to write data");
+                return ERR_NO_FREE_BLOCKS;
+            }
+            file_inode->direct_blocks[index] = block;
+        }
+
+        size_t chunk = BLOCK_SIZE - block_offset;
+        if (chunk > len - written) chunk = len - written;
+
+        memcpy(image + block * BLOCK_SIZE + block_offset, data + written, chunk);
+        mark_block_dirty(block);
+        written += chunk;
+    }
+
+    // Logical blocks skipped over by the offset stay unmapped and read back as zeros
+    if (offset + len > file_inode->size) {
+        file_inode->size = offset + len;
+    }
+    mark_range_dirty(image, file_inode, sizeof(struct inode));
+
+    memcpy(image + BLOCK_SIZE * SUPERBLOCK_BLOCK, sb, sizeof(struct superblock));
+    mark_block_dirty(SUPERBLOCK_BLOCK);
+
+    return 0;
+}
+
+int acnn_fallocate(uint8_t *image, struct superblock *sb, struct inode *file_inode, uint32_t offset, uint32_t len) {
+    if (!image || !sb || !file_inode || len == 0) {
+        log_error("Invalid arguments passed to acnn_fallocate");
+        return ERR_INVALID_ARGUMENTS;
+    }
+
+    if ((size_t)offset + len > 10 * BLOCK_SIZE) {
+        log_error("Preallocation of %u bytes at offset %u exceeds direct block limit", len, offset);
+        return ERR_FILE_TOO_LARGE;
+    }
+
+    uint32_t first = offset / BLOCK_SIZE;
+    uint32_t last = (offset + len - 1) / BLOCK_SIZE;
+
+    uint32_t unmapped = 0;
+    for (uint32_t i = first; i <= last; i++) {
+        if (file_inode->direct_blocks[i] == 0) unmapped++;
+    }
+
+    if (unmapped > 0) {
+        uint32_t block = allocate_data_run(image, sb, unmapped);
+        if (block == (uint32_t)-1) {
+            log_error("No contiguous run of %u blocks available for preallocation", unmapped);
+            return ERR_NO_FREE_BLOCKS;
+        }
+
+        // Free blocks are already zero, so the run is mapped without touching its contents
+        for (uint32_t i = first; i <= last; i++) {
+            if (file_inode->direct_blocks[i] == 0) {
+                file_inode->direct_blocks[i] = block++;
+            }
+        }
+    }
+
+    if (offset + len > file_inode->size) {
+        file_inode->size = offset + len;
+    }
+    mark_range_dirty(image, file_inode, sizeof(struct inode));
+
+    memcpy(image + BLOCK_SIZE * SUPERBLOCK_BLOCK, sb, sizeof(struct superblock));
+    mark_block_dirty(SUPERBLOCK_BLOCK);
+
+    log_info("Preallocated %u blocks for range %u-%u", unmapped, offset, offset + len - 1);
+    return 0;
 }
\ No newline at end of file
@@ -16,6 +16,7 @@ uint32_t allocate_inode(uint8_t *image, struct superblock *sb) {
         if (!(inode_bitmap[byte_idx] & (1 << bit_idx))) {
             inode_bitmap[byte_idx] |= (1 << bit_idx);
             sb->free_inodes--;
+            mark_block_dirty(INODE_BITMAP_BLOCK);
 
             return i;
         }
@@ -9,6 +9,15 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+static int is_zero(const char *buf, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (buf[i] != 0) return 0;
+    }
+    return 1;
+}
 
 int main(int argc, char *argv[]) {
     char output_dir[PATH_MAX];
@@ -39,7 +48,12 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
-    FILE *out = NULL;
+    if (acnn_dirty_init(total_blocks) != 0) {
+        cleanup(image, -1);
+        return 1;
+    }
+
+    int fd = -1;
 
     struct superblock sb = {
         .magic_number = 0xA2C0F0F8,
@@ -55,6 +69,7 @@ int main(int argc, char *argv[]) {
     };
 
     memcpy(image + BLOCK_SIZE * SUPERBLOCK_BLOCK, &sb, sizeof(struct superblock));
+    mark_block_dirty(SUPERBLOCK_BLOCK);
 
     struct superblock *sb_check = (struct superblock *)(image + BLOCK_SIZE * SUPERBLOCK_BLOCK);
     log_info("Superblock verification:");
@@ -65,48 +80,120 @@ int main(int argc, char *argv[]) {
     log_info("Total Inodes: %u", sb_check->total_inodes);
     log_info("Free Inodes: %u", sb_check->free_inodes);
 
+    // Claim block 32 before writing to it so free blocks stay zero
+    uint8_t *block_bitmap = image + BLOCK_SIZE * BLOCK_BITMAP_BLOCK;
+    block_bitmap[32 / 8] |= (1 << (32 % 8));
+    sb.free_blocks--;
+    mark_block_dirty(BLOCK_BITMAP_BLOCK);
+
     const char *test_data = "Hello, Block 32!";
     memcpy(image + BLOCK_SIZE * 32, test_data, strlen(test_data));
+    mark_block_dirty(32);
 
     log_info("Test data written to block 32: %s", test_data);
 
+    initialize_reserved_blocks(image, &sb);
+
     uint32_t root_data_block = allocate_data_block(image, sb.total_blocks, &sb);
     if (root_data_block == (uint32_t)-1) {
         log_error("Failed to allocate root data block");
-        cleanup(image, out);
+        cleanup(image, fd);
         return 1;
     }
 
-    initialize_reserved_blocks(image, &sb);
-
     struct dir_entry *root_entries = (struct dir_entry *)(image + BLOCK_SIZE * root_data_block);
     memset(root_entries, 0, BLOCK_SIZE); 
 
     struct inode *root_inode = (struct inode *)(image + BLOCK_SIZE * INODE_TABLE_BLOCK);
     root_inode->direct_blocks[0] = root_data_block;
     root_inode->size = 0; 
+    mark_range_dirty(image, root_inode, sizeof(struct inode));
+
+    uint8_t *inode_bitmap = image + BLOCK_SIZE * INODE_BITMAP_BLOCK;
+    inode_bitmap[sb.root_inode / 8] |= (1 << (sb.root_inode % 8));
+    mark_block_dirty(INODE_BITMAP_BLOCK);
 
     char file_path[PATH_MAX];
     int n = snprintf(file_path, sizeof(file_path), "%s/acnn.img", output_dir);
     if(n < 0 || (unsigned)n >= sizeof(file_path)) {
         fprintf(stderr, "File path is too long or an encoding error occurred\n");
-        cleanup(image, out);
+        cleanup(image, fd);
         return 1;
     }
-    out = fopen(file_path, "wb");
-    if (!out) {
+    fd = open(file_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
         perror("Failed to open output file");
-        cleanup(image, out);
+        cleanup(image, fd);
+        return 1;
+    }
+
+    // Size the image up front; blocks that are never dirtied stay as holes.
+    if (ftruncate(fd, disk_size) != 0) {
+        perror("Failed to size output file");
+        cleanup(image, fd);
         return 1;
     }
 
-    if (fwrite(image, 1, disk_size, out) != disk_size) {
+    // Sparse file: a hole, a preallocated range and a block released back to the host
+    uint32_t sparse_idx = allocate_inode(image, &sb);
+    if (sparse_idx == (uint32_t)-1 || add_dir_entry(image, &sb, sb.root_inode, sparse_idx, "sparse.txt") != 0) {
+        log_error("Failed to create sparse file");
+        cleanup(image, fd);
+        return 1;
+    }
+
+    struct inode *sparse_inode = (struct inode *)(image + BLOCK_SIZE * INODE_TABLE_BLOCK) + sparse_idx;
+    const char *sparse_data = "Hello, sparse file!";
+    size_t sparse_len = strlen(sparse_data);
+
+    if (write_file_at(image, &sb, sparse_inode, 2 * BLOCK_SIZE, sparse_data, sparse_len) != 0 ||
+        acnn_fallocate(image, &sb, sparse_inode, 3 * BLOCK_SIZE, 2 * BLOCK_SIZE) != 0) {
+        log_error("Failed to populate sparse file");
+        cleanup(image, fd);
+        return 1;
+    }
+
+    if (acnn_sync(image, fd, 0) != 0) {
+        log_error("Failed to write data to output file");
+        cleanup(image, fd);
+        return 1;
+    }
+
+    char sparse_buf[10 * BLOCK_SIZE + 1];
+    read_file(image, sparse_inode, sparse_buf, sizeof(sparse_buf));
+    if (!is_zero(sparse_buf, 2 * BLOCK_SIZE) ||
+        memcmp(sparse_buf + 2 * BLOCK_SIZE, sparse_data, sparse_len) != 0 ||
+        !is_zero(sparse_buf + 3 * BLOCK_SIZE, 2 * BLOCK_SIZE)) {
+        log_error("Sparse file read back incorrectly");
+        cleanup(image, fd);
+        return 1;
+    }
+
+    log_info("Sparse file read back: %u bytes with a hole over blocks 0-1", sparse_inode->size);
+    log_info("Root directory block %u, sparse file blocks %u %u %u", root_inode->direct_blocks[0],
+             sparse_inode->direct_blocks[2], sparse_inode->direct_blocks[3], sparse_inode->direct_blocks[4]);
+
+    free_data_block(image, &sb, sparse_inode->direct_blocks[2]);
+    sparse_inode->direct_blocks[2] = 0;
+    mark_range_dirty(image, sparse_inode, sizeof(struct inode));
+
+    read_file(image, sparse_inode, sparse_buf, sizeof(sparse_buf));
+    if (!is_zero(sparse_buf, sparse_inode->size)) {
+        log_error("Released sparse file block did not read back as a hole");
+        cleanup(image, fd);
+        return 1;
+    }
+
+    memcpy(image + BLOCK_SIZE * SUPERBLOCK_BLOCK, &sb, sizeof(struct superblock));
+    mark_block_dirty(SUPERBLOCK_BLOCK);
+
+    if (acnn_sync(image, fd, 1) != 0) {
         log_error("Failed to write data to output file");
-        cleanup(image, out);
+        cleanup(image, fd);
         return 1;
     }
 
-    cleanup(image, out);
+    cleanup(image, fd);
     log_info("Filesystem created successfully.");
     return 0;
 } 
\ No newline at end of file
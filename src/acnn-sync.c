@@ -0,0 +1,213 @@
+#define _GNU_SOURCE
+#include "../include/acnn.h"
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// State for the single image this process works on; see acnn.h
+static uint8_t *dirty_bitmap = NULL;
+static uint8_t *discard_bitmap = NULL;
+static uint8_t *prealloc_bitmap = NULL;
+static uint32_t dirty_total_blocks = 0;
+
+typedef int (*run_fn)(uint8_t *image, int fd, uint32_t start, uint32_t count);
+
+int acnn_dirty_init(uint32_t total_blocks) {
+    acnn_dirty_free();
+
+    size_t bitmap_size = (total_blocks + 7) / 8;
+    dirty_bitmap = calloc(bitmap_size, 1);
+    discard_bitmap = calloc(bitmap_size, 1);
+    prealloc_bitmap = calloc(bitmap_size, 1);
+    if (!dirty_bitmap || !discard_bitmap || !prealloc_bitmap) {
+        log_error("Failed to allocate dirty block bitmaps");
+        acnn_dirty_free();
+        return ERR_OUT_OF_MEMORY;
+    }
+
+    dirty_total_blocks = total_blocks;
+    return 0;
+}
+
+void acnn_dirty_free(void) {
+    free(dirty_bitmap);
+    free(discard_bitmap);
+    free(prealloc_bitmap);
+    dirty_bitmap = NULL;
+    discard_bitmap = NULL;
+    prealloc_bitmap = NULL;
+    dirty_total_blocks = 0;
+}
+
+static int block_in_bitmap(const uint8_t *bitmap, uint32_t block_index) {
+    return bitmap[block_index / 8] & (1 << (block_index % 8));
+}
+
+static void set_block(uint8_t *bitmap, uint32_t block_index) {
+    bitmap[block_index / 8] |= (1 << (block_index % 8));
+}
+
+static void clear_block(uint8_t *bitmap, uint32_t block_index) {
+    bitmap[block_index / 8] &= ~(1 << (block_index % 8));
+}
+
+void mark_block_dirty(uint32_t block_index) {
+    if (!dirty_bitmap || block_index >= dirty_total_blocks) return;
+
+    set_block(dirty_bitmap, block_index);
+    clear_block(discard_bitmap, block_index);
+}
+
+void mark_block_discard(uint32_t block_index) {
+    if (!dirty_bitmap || block_index >= dirty_total_blocks) return;
+
+    set_block(discard_bitmap, block_index);
+    clear_block(dirty_bitmap, block_index);
+    clear_block(prealloc_bitmap, block_index);
+}
+
+/*
+ * A reused block may still hold its previous owner's data on disk, and
+ * preallocation does not zero allocated extents. Any pending discard is
+ * kept so acnn_sync() punches the block before preallocating it.
+ */
+void mark_block_prealloc(uint32_t block_index) {
+    if (!dirty_bitmap || block_index >= dirty_total_blocks) return;
+
+    set_block(prealloc_bitmap, block_index);
+}
+
+void mark_range_dirty(uint8_t *image, const void *addr, size_t len) {
+    if (!image || !addr || len == 0) return;
+
+    size_t offset = (const uint8_t *)addr - image;
+    if (offset >= (size_t)dirty_total_blocks * BLOCK_SIZE) return;
+
+    uint32_t first = offset / BLOCK_SIZE;
+    uint32_t last = (offset + len - 1) / BLOCK_SIZE;
+
+    for (uint32_t i = first; i <= last; i++) {
+        mark_block_dirty(i);
+    }
+}
+
+/*
+ * The in-memory image mirrors the file layout, so a run of adjacent dirty
+ * blocks is already one contiguous buffer at one contiguous file offset and
+ * goes out in a single positioned write.
+ */
+static int write_run(uint8_t *image, int fd, uint32_t start, uint32_t count) {
+    uint8_t *buf = image + (size_t)start * BLOCK_SIZE;
+    size_t remaining = (size_t)count * BLOCK_SIZE;
+    off_t offset = (off_t)start * BLOCK_SIZE;
+
+    while (remaining > 0) {
+        ssize_t written = pwrite(fd, buf, remaining, offset);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            log_error("Failed to write blocks %u-%u: %s", start, start + count - 1, strerror(errno));
+            return ERR_FILE_WRITE_FAILED;
+        }
+
+        buf += written;
+        offset += written;
+        remaining -= written;
+    }
+
+    return 0;
+}
+
+/*
+ * Freed blocks are kept zeroed in memory, so if the host filesystem cannot
+ * punch holes the same run can simply be written out instead.
+ */
+static int punch_run(uint8_t *image, int fd, uint32_t start, uint32_t count) {
+    off_t offset = (off_t)start * BLOCK_SIZE;
+    off_t len = (off_t)count * BLOCK_SIZE;
+
+    if (fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, offset, len) == 0) {
+        return 0;
+    }
+
+    if (errno != EOPNOTSUPP && errno != ENOSYS) {
+        log_error("Failed to punch blocks %u-%u: %s", start, start + count - 1, strerror(errno));
+        return ERR_FILE_WRITE_FAILED;
+    }
+
+    return write_run(image, fd, start, count);
+}
+
+static int prealloc_run(uint8_t *image, int fd, uint32_t start, uint32_t count) {
+    (void)image;
+    off_t offset = (off_t)start * BLOCK_SIZE;
+    off_t len = (off_t)count * BLOCK_SIZE;
+
+    if (fallocate(fd, FALLOC_FL_KEEP_SIZE, offset, len) == 0) {
+        return 0;
+    }
+
+    if (errno != EOPNOTSUPP && errno != ENOSYS) {
+        log_error("Failed to preallocate blocks %u-%u: %s", start, start + count - 1, strerror(errno));
+        return ERR_FILE_WRITE_FAILED;
+    }
+
+    return 0; // Preallocation is only a hint
+}
+
+static int flush_runs(uint8_t *image, int fd, uint8_t *bitmap, run_fn fn, uint32_t *flushed) {
+    uint32_t i = 0;
+
+    while (i < dirty_total_blocks) {
+        if (!bitmap[i / 8]) {
+            i = (i / 8 + 1) * 8;
+            continue;
+        }
+
+        if (!block_in_bitmap(bitmap, i)) {
+            i++;
+            continue;
+        }
+
+        uint32_t start = i;
+        while (i < dirty_total_blocks && block_in_bitmap(bitmap, i)) {
+            i++;
+        }
+
+        int rc = fn(image, fd, start, i - start);
+        if (rc != 0) return rc;
+
+        *flushed += i - start;
+    }
+
+    memset(bitmap, 0, (dirty_total_blocks + 7) / 8);
+    return 0;
+}
+
+int acnn_sync(uint8_t *image, int fd, int datasync) {
+    if (!image || fd < 0 || !dirty_bitmap) {
+        log_error("Invalid arguments passed to acnn_sync");
+        return ERR_INVALID_ARGUMENTS;
+    }
+
+    uint32_t punched = 0;
+    uint32_t preallocated = 0;
+    uint32_t flushed = 0;
+
+    int rc = flush_runs(image, fd, discard_bitmap, punch_run, &punched);
+    if (rc != 0) return rc;
+
+    rc = flush_runs(image, fd, prealloc_bitmap, prealloc_run, &preallocated);
+    if (rc != 0) return rc;
+
+    rc = flush_runs(image, fd, dirty_bitmap, write_run, &flushed);
+    if (rc != 0) return rc;
+
+    if (datasync && fdatasync(fd) != 0) {
+        log_error("fdatasync failed: %s", strerror(errno));
+        return ERR_FILE_WRITE_FAILED;
+    }
+
+    log_info("Synced %u dirty blocks, punched %u, preallocated %u", flushed, punched, preallocated);
+    return 0;
+}
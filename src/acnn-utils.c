@@ -3,6 +3,7 @@
 #include <stdlib.h>
 #include <stdarg.h>
 #include <string.h>
+#include <unistd.h>
 
 void log_error(const char *format, ...) {
     va_list args;
@@ -36,19 +37,23 @@ void handle_error(int error_code, const char *message) {
         case ERR_FILE_TOO_LARGE:
             log_error("File too large: %s", message);
             break;
+        case ERR_OUT_OF_MEMORY:
+            log_error("Out of memory: %s", message);
+            break;
         default:
             log_error("Unknown error: %s", message);
             break;
     }
 }
 
-void cleanup(uint8_t *image, FILE *out) {
+void cleanup(uint8_t *image, int fd) {
     if (image) {
         free(image);
         log_info("Memory freed successfully");
     }
-    if (out) {
-        fclose(out);
+    acnn_dirty_free();
+    if (fd >= 0) {
+        close(fd);
         log_info("File closed successfully");
     }
 }